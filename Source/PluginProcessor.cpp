@@ -22,6 +22,10 @@ KopczynskiXTCAudioProcessor::KopczynskiXTCAudioProcessor()
                        )
 #endif
 {
+    /* linear-phase FIR half-bands delay every frequency by the same amount,
+       so the integer padding on the other bands keeps the sum coherent */
+    oversampling2x = std::make_unique<Oversampling>(2, 1, Oversampling::filterHalfBandFIREquiripple, true, true);
+    oversampling4x = std::make_unique<Oversampling>(2, 2, Oversampling::filterHalfBandFIREquiripple, true, true);
 }
 
 KopczynskiXTCAudioProcessor::~KopczynskiXTCAudioProcessor()
@@ -102,11 +106,59 @@ void KopczynskiXTCAudioProcessor::prepareToPlay (double sampleRate, int samplesP
     spec.numChannels = 1;
     spec.sampleRate = sampleRate;
     
+    /* crossovers start at the parameter values, later changes ramp */
+    auto chainSettings = getChainSettings(apvts);
+    
+    lowCrossoverSmoother.reset(sampleRate, 0.05);
+    highCrossoverSmoother.reset(sampleRate, 0.05);
+    lowCrossoverSmoother.setCurrentAndTargetValue(chainSettings.lowCrossover);
+    highCrossoverSmoother.setCurrentAndTargetValue(chainSettings.highCrossover);
+    
+    /* preallocate work buffers so processBlock never allocates */
+    maxSubBlockSize = juce::jmax(1, samplesPerBlock);
+    
+    bpBuffer.setSize(2, maxSubBlockSize);
+    lpBuffer.setSize(2, maxSubBlockSize);
+    hpBuffer.setSize(2, maxSubBlockSize);
+    
     leftBPChain.prepare(spec);
     rightBPChain.prepare(spec);
     
-    leftRecChain.prepare(spec);
-    rightRecChain.prepare(spec);
+    /* recursion runs at up to 4x the host rate, size delay lines for the longest delay there */
+    juce::dsp::ProcessSpec recSpec = spec;
+    recSpec.maximumBlockSize = maxSubBlockSize * 4;
+    recSpec.sampleRate = sampleRate * 4;
+    
+    auto maxDelayInSamples = juce::roundToInt(std::ceil(apvts.getParameterRange("Delay").end * 0.001 * recSpec.sampleRate)) + 1;
+    
+    leftRecChain.get<RecChainPositions::Delay>().setMaximumDelayInSamples(maxDelayInSamples);
+    rightRecChain.get<RecChainPositions::Delay>().setMaximumDelayInSamples(maxDelayInSamples);
+    
+    leftRecChain.prepare(recSpec);
+    rightRecChain.prepare(recSpec);
+    
+    oversampling2x->initProcessing(static_cast<size_t>(maxSubBlockSize));
+    oversampling4x->initProcessing(static_cast<size_t>(maxSubBlockSize));
+    
+    /* report the 4x latency in every mode, the BP path pads the remainder and LP/HP take all of it,
+       so the host never sees the latency change when the oversampling parameter moves */
+    juce::dsp::ProcessSpec latencySpec = spec;
+    latencySpec.numChannels = 2;
+    
+    reportedLatency = juce::roundToInt(oversampling4x->getLatencyInSamples());
+    
+    bpLatencyDelay.setMaximumDelayInSamples(reportedLatency + 1);
+    lpLatencyDelay.setMaximumDelayInSamples(reportedLatency + 1);
+    hpLatencyDelay.setMaximumDelayInSamples(reportedLatency + 1);
+    
+    bpLatencyDelay.prepare(latencySpec);
+    lpLatencyDelay.prepare(latencySpec);
+    hpLatencyDelay.prepare(latencySpec);
+    
+    lpLatencyDelay.setDelay(static_cast<float>(reportedLatency));
+    hpLatencyDelay.setDelay(static_cast<float>(reportedLatency));
+    
+    setLatencySamples(reportedLatency);
     
     leftHPChain.prepare(spec);
     rightHPChain.prepare(spec);
@@ -114,7 +166,20 @@ void KopczynskiXTCAudioProcessor::prepareToPlay (double sampleRate, int samplesP
     leftLPChain.prepare(spec);
     rightLPChain.prepare(spec);
     
+    /* set filter responses, cutoffs follow the smoothed crossover parameters */
+    setCutChainType(leftBPChain.get<BPChainPositions::BPHighPass>(), juce::dsp::StateVariableTPTFilterType::highpass);
+    setCutChainType(rightBPChain.get<BPChainPositions::BPHighPass>(), juce::dsp::StateVariableTPTFilterType::highpass);
+    setCutChainType(leftBPChain.get<BPChainPositions::BPLowPass>(), juce::dsp::StateVariableTPTFilterType::lowpass);
+    setCutChainType(rightBPChain.get<BPChainPositions::BPLowPass>(), juce::dsp::StateVariableTPTFilterType::lowpass);
+    
+    setCutChainType(leftHPChain, juce::dsp::StateVariableTPTFilterType::highpass);
+    setCutChainType(rightHPChain, juce::dsp::StateVariableTPTFilterType::highpass);
+    setCutChainType(leftLPChain, juce::dsp::StateVariableTPTFilterType::lowpass);
+    setCutChainType(rightLPChain, juce::dsp::StateVariableTPTFilterType::lowpass);
+    
     /* set initial attenuation, delay, and filteer coefficients/slopes */
+    filtersNeedUpdate = true;
+    appliedOversampling = -1;
     updateAll();
     
 }
@@ -134,6 +199,13 @@ void KopczynskiXTCAudioProcessor::releaseResources()
     
     leftLPChain.reset();
     rightLPChain.reset();
+    
+    oversampling2x->reset();
+    oversampling4x->reset();
+    
+    bpLatencyDelay.reset();
+    lpLatencyDelay.reset();
+    hpLatencyDelay.reset();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -176,265 +248,163 @@ void KopczynskiXTCAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer
     /* update attenuation, delay, and filter slope */
     updateAll();
     
-    /* copy buffer into temporary buffers to be processed */
-    juce::AudioBuffer<float> bpBuffer;
-    bpBuffer.makeCopyOf(buffer);
-    
-    juce::AudioBuffer<float> lpBuffer;
-    lpBuffer.makeCopyOf(buffer);
-    
-    juce::AudioBuffer<float> hpBuffer;
-    hpBuffer.makeCopyOf(buffer);
-    
-    /* create bandpass audioblock and process */
-    juce::dsp::AudioBlock<float> bpBlock(bpBuffer);
-    
-    auto leftBPBlock = bpBlock.getSingleChannelBlock(LEFT_CHANNEL);
-    auto rightBPBlock = bpBlock.getSingleChannelBlock(RIGHT_CHANNEL);
-    
-    juce::dsp::ProcessContextReplacing<float> leftBPContext(leftBPBlock);
-    juce::dsp::ProcessContextReplacing<float> rightBPContext(rightBPBlock);
-    
-    leftBPChain.process(leftBPContext);
-    rightBPChain.process(rightBPContext);
+    /* hosts may exceed the prepared block size, split so the oversamplers and work buffers never overrun */
+    for (int startSample = 0; startSample < bufferSize; startSample += maxSubBlockSize)
+        processSubBlock(buffer, startSample, juce::jmin(maxSubBlockSize, bufferSize - startSample));
+}
+
+void KopczynskiXTCAudioProcessor::processSubBlock (juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    /* copy buffer into preallocated temporary buffers to be processed */
+    bpBuffer.setSize(2, numSamples, false, false, true);
+    lpBuffer.setSize(2, numSamples, false, false, true);
+    hpBuffer.setSize(2, numSamples, false, false, true);
     
-    /* iterate processing multiple times */
-    for (int i = 0; i < 40; ++i)
+    for (int channel = LEFT_CHANNEL; channel <= RIGHT_CHANNEL; ++channel)
     {
-        leftRecChain.process(rightBPContext);
-        rightRecChain.process(leftBPContext);
+        bpBuffer.copyFrom(channel, 0, buffer, channel, startSample, numSamples);
+        lpBuffer.copyFrom(channel, 0, buffer, channel, startSample, numSamples);
+        hpBuffer.copyFrom(channel, 0, buffer, channel, startSample, numSamples);
     }
     
-    
-    /* copy LP buffer into audioblock to be processed */
+    /* split the copies into bands */
+    juce::dsp::AudioBlock<float> bpBlock(bpBuffer);
     juce::dsp::AudioBlock<float> lpBlock(lpBuffer);
-    
-    auto leftLPBlock = lpBlock.getSingleChannelBlock(LEFT_CHANNEL);
-    auto rightLPBlock = lpBlock.getSingleChannelBlock(RIGHT_CHANNEL);
-    
-    juce::dsp::ProcessContextReplacing<float> leftLPContext(leftLPBlock);
-    juce::dsp::ProcessContextReplacing<float> rightLPContext(rightLPBlock);
-    
-    leftLPChain.process(leftLPContext);
-    rightLPChain.process(rightLPContext);
-    
-    /* copy HP buffer into audioblock to be processed */
     juce::dsp::AudioBlock<float> hpBlock(hpBuffer);
     
-    auto leftHPBlock = hpBlock.getSingleChannelBlock(LEFT_CHANNEL);
-    auto rightHPBlock = hpBlock.getSingleChannelBlock(RIGHT_CHANNEL);
+    splitBands(bpBlock, lpBlock, hpBlock);
     
-    juce::dsp::ProcessContextReplacing<float> leftHPContext(leftHPBlock);
-    juce::dsp::ProcessContextReplacing<float> rightHPContext(rightHPBlock);
+    /* run the recursion on the band-limited signal, oversampled if enabled */
+    if (auto* oversampling = getOversampling(appliedOversampling))
+    {
+        auto osBlock = oversampling->processSamplesUp(bpBlock);
+        processRecursion(osBlock);
+        oversampling->processSamplesDown(bpBlock);
+    }
+    else
+    {
+        processRecursion(bpBlock);
+    }
     
-    leftHPChain.process(leftHPContext);
-    rightHPChain.process(rightHPContext);
+    /* pad every path to the fixed reported latency */
+    if (appliedOversampling != OversamplingTypes::Oversampling4x)
+        bpLatencyDelay.process(juce::dsp::ProcessContextReplacing<float>(bpBlock));
     
+    lpLatencyDelay.process(juce::dsp::ProcessContextReplacing<float>(lpBlock));
+    hpLatencyDelay.process(juce::dsp::ProcessContextReplacing<float>(hpBlock));
     
     /* fill original buffer with bandpassed buffer */
-    buffer.copyFrom(LEFT_CHANNEL, 0, bpBuffer, LEFT_CHANNEL, 0, bufferSize);
-    buffer.copyFrom(RIGHT_CHANNEL, 0, bpBuffer, RIGHT_CHANNEL, 0, bufferSize);
+    buffer.copyFrom(LEFT_CHANNEL, startSample, bpBuffer, LEFT_CHANNEL, 0, numSamples);
+    buffer.copyFrom(RIGHT_CHANNEL, startSample, bpBuffer, RIGHT_CHANNEL, 0, numSamples);
     
     /* add low-passed signal */
-    buffer.addFrom(LEFT_CHANNEL, 0, lpBuffer, LEFT_CHANNEL, 0, bufferSize);
-    buffer.addFrom(RIGHT_CHANNEL, 0, lpBuffer, RIGHT_CHANNEL, 0, bufferSize);
+    buffer.addFrom(LEFT_CHANNEL, startSample, lpBuffer, LEFT_CHANNEL, 0, numSamples);
+    buffer.addFrom(RIGHT_CHANNEL, startSample, lpBuffer, RIGHT_CHANNEL, 0, numSamples);
     
     /* add high-passed signal */
-    buffer.addFrom(LEFT_CHANNEL, 0, hpBuffer, LEFT_CHANNEL, 0, bufferSize);
-    buffer.addFrom(RIGHT_CHANNEL, 0, hpBuffer, RIGHT_CHANNEL, 0, bufferSize);
+    buffer.addFrom(LEFT_CHANNEL, startSample, hpBuffer, LEFT_CHANNEL, 0, numSamples);
+    buffer.addFrom(RIGHT_CHANNEL, startSample, hpBuffer, RIGHT_CHANNEL, 0, numSamples);
 }
 
-void KopczynskiXTCAudioProcessor::updateCoefficients (Coefficients& old, const Coefficients& replacements)
+void KopczynskiXTCAudioProcessor::processRecursion (juce::dsp::AudioBlock<float>& block)
 {
-    *old = *replacements;
+    auto leftBlock = block.getSingleChannelBlock(LEFT_CHANNEL);
+    auto rightBlock = block.getSingleChannelBlock(RIGHT_CHANNEL);
+    
+    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
+    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+    
+    /* iterate processing multiple times */
+    for (int i = 0; i < 40; ++i)
+    {
+        leftRecChain.process(rightContext);
+        rightRecChain.process(leftContext);
+    }
 }
 
-void KopczynskiXTCAudioProcessor::updateFilters(const ChainSettings &chainSettings)
+template <typename ChainType>
+void KopczynskiXTCAudioProcessor::processChannel (ChainType& chain, const juce::dsp::AudioBlock<float>& block, size_t channel)
 {
-    auto bpHPCoeff = juce::dsp::IIR::Coefficients<float>::makeHighPass(getSampleRate(), 250.f);
-    auto bpLPCoeff = juce::dsp::IIR::Coefficients<float>::makeLowPass(getSampleRate(), 5000.f);
-    auto hpCoeff = juce::dsp::IIR::Coefficients<float>::makeHighPass(getSampleRate(), 250.f);
-    auto lpCoeff = juce::dsp::IIR::Coefficients<float>::makeLowPass(getSampleRate(), 5000.f);
-    
-    auto& leftHighPass = leftBPChain.get<BPChainPositions::BPHighPass>();
-    
-    leftHighPass.setBypassed<0>(true);
-    leftHighPass.setBypassed<1>(true);
-    leftHighPass.setBypassed<2>(true);
-    
-    auto& rightHighPass = rightBPChain.get<BPChainPositions::BPHighPass>();
-    
-    rightHighPass.setBypassed<0>(true);
-    rightHighPass.setBypassed<1>(true);
-    rightHighPass.setBypassed<2>(true);
-    
-    auto& leftLowPass = leftBPChain.get<BPChainPositions::BPLowPass>();
-    
-    leftLowPass.setBypassed<0>(true);
-    leftLowPass.setBypassed<1>(true);
-    leftLowPass.setBypassed<2>(true);
-    
-    auto& rightLowPass = rightBPChain.get<BPChainPositions::BPLowPass>();
+    auto channelBlock = block.getSingleChannelBlock(channel);
+    juce::dsp::ProcessContextReplacing<float> context(channelBlock);
     
-    rightLowPass.setBypassed<0>(true);
-    rightLowPass.setBypassed<1>(true);
-    rightLowPass.setBypassed<2>(true);
-    
-    leftHPChain.setBypassed<0>(true);
-    leftHPChain.setBypassed<1>(true);
-    leftHPChain.setBypassed<2>(true);
-    
-    rightHPChain.setBypassed<0>(true);
-    rightHPChain.setBypassed<1>(true);
-    rightHPChain.setBypassed<2>(true);
-    
-    leftLPChain.setBypassed<0>(true);
-    leftLPChain.setBypassed<1>(true);
-    leftLPChain.setBypassed<2>(true);
-    
-    rightLPChain.setBypassed<0>(true);
-    rightLPChain.setBypassed<1>(true);
-    rightLPChain.setBypassed<2>(true);
+    chain.process(context);
+}
+
+void KopczynskiXTCAudioProcessor::splitBands (juce::dsp::AudioBlock<float>& bpBlock,
+                                              juce::dsp::AudioBlock<float>& lpBlock,
+                                              juce::dsp::AudioBlock<float>& hpBlock)
+{
+    auto numSamples = bpBlock.getNumSamples();
     
-    switch ( chainSettings.filterType )
+    for (size_t start = 0; start < numSamples;)
     {
-        case 0:
+        auto sliceSize = numSamples - start;
+        
+        /* while a crossover ramps, retune the TPT stages every few samples so sweeps don't zipper */
+        if (lowCrossoverSmoother.isSmoothing() || highCrossoverSmoother.isSmoothing())
         {
-            updateCoefficients(leftHighPass.get<0>().coefficients, bpHPCoeff);
-            leftHighPass.setBypassed<0>(false);
-            
-            updateCoefficients(rightHighPass.get<0>().coefficients, bpHPCoeff);
-            rightHighPass.setBypassed<0>(false);
-            
-            updateCoefficients(leftLowPass.get<0>().coefficients, bpLPCoeff);
-            leftLowPass.setBypassed<0>(false);
-            
-            updateCoefficients(rightLowPass.get<0>().coefficients, bpLPCoeff);
-            rightLowPass.setBypassed<0>(false);
-            
-            updateCoefficients(leftHPChain.get<0>().coefficients, hpCoeff);
-            leftHPChain.setBypassed<0>(false);
-            
-            updateCoefficients(rightHPChain.get<0>().coefficients, hpCoeff);
-            rightHPChain.setBypassed<0>(false);
-            
-            updateCoefficients(leftLPChain.get<0>().coefficients, lpCoeff);
-            leftLPChain.setBypassed<0>(false);
-            
-            updateCoefficients(rightLPChain.get<0>().coefficients, lpCoeff);
-            rightLPChain.setBypassed<0>(false);
-            
-            break;
-        }
-            
-        case 1:
-        {
-            updateCoefficients(leftHighPass.get<0>().coefficients, bpHPCoeff);
-            leftHighPass.setBypassed<0>(false);
-            updateCoefficients(leftHighPass.get<1>().coefficients, bpHPCoeff);
-            leftHighPass.setBypassed<1>(false);
-            
-            updateCoefficients(rightHighPass.get<0>().coefficients, bpHPCoeff);
-            rightHighPass.setBypassed<0>(false);
-            updateCoefficients(rightHighPass.get<1>().coefficients, bpHPCoeff);
-            rightHighPass.setBypassed<1>(false);
-            
-            updateCoefficients(leftLowPass.get<0>().coefficients, bpLPCoeff);
-            leftLowPass.setBypassed<0>(false);
-            updateCoefficients(leftLowPass.get<1>().coefficients, bpLPCoeff);
-            leftLowPass.setBypassed<1>(false);
-            
-            updateCoefficients(rightLowPass.get<0>().coefficients, bpLPCoeff);
-            rightLowPass.setBypassed<0>(false);
-            updateCoefficients(rightLowPass.get<1>().coefficients, bpLPCoeff);
-            rightLowPass.setBypassed<1>(false);
-            
-            updateCoefficients(leftHPChain.get<0>().coefficients, hpCoeff);
-            leftHPChain.setBypassed<0>(false);
-            updateCoefficients(leftHPChain.get<1>().coefficients, hpCoeff);
-            leftHPChain.setBypassed<1>(false);
-            
-            updateCoefficients(rightHPChain.get<0>().coefficients, hpCoeff);
-            rightHPChain.setBypassed<0>(false);
-            updateCoefficients(rightHPChain.get<1>().coefficients, hpCoeff);
-            rightHPChain.setBypassed<1>(false);
-            
-            updateCoefficients(leftLPChain.get<0>().coefficients, lpCoeff);
-            leftLPChain.setBypassed<0>(false);
-            updateCoefficients(leftLPChain.get<1>().coefficients, lpCoeff);
-            leftLPChain.setBypassed<1>(false);
-            
-            updateCoefficients(rightLPChain.get<0>().coefficients, lpCoeff);
-            rightLPChain.setBypassed<0>(false);
-            updateCoefficients(rightLPChain.get<1>().coefficients, lpCoeff);
-            rightLPChain.setBypassed<1>(false);
-            
-            break;
-        }
-            
-        case 2:
-        {
-            updateCoefficients(leftHighPass.get<0>().coefficients, bpHPCoeff);
-            leftHighPass.setBypassed<0>(false);
-            updateCoefficients(leftHighPass.get<1>().coefficients, bpHPCoeff);
-            leftHighPass.setBypassed<1>(false);
-            updateCoefficients(leftHighPass.get<2>().coefficients, bpHPCoeff);
-            leftHighPass.setBypassed<2>(false);
-            
-            updateCoefficients(rightHighPass.get<0>().coefficients, bpHPCoeff);
-            rightHighPass.setBypassed<0>(false);
-            updateCoefficients(rightHighPass.get<1>().coefficients, bpHPCoeff);
-            rightHighPass.setBypassed<1>(false);
-            updateCoefficients(rightHighPass.get<2>().coefficients, bpHPCoeff);
-            rightHighPass.setBypassed<3>(false);
-            
-            updateCoefficients(leftLowPass.get<0>().coefficients, bpLPCoeff);
-            leftLowPass.setBypassed<0>(false);
-            updateCoefficients(leftLowPass.get<1>().coefficients, bpLPCoeff);
-            leftLowPass.setBypassed<1>(false);
-            updateCoefficients(leftLowPass.get<2>().coefficients, bpLPCoeff);
-            leftLowPass.setBypassed<2>(false);
-            
-            updateCoefficients(rightLowPass.get<0>().coefficients, bpLPCoeff);
-            rightLowPass.setBypassed<0>(false);
-            updateCoefficients(rightLowPass.get<1>().coefficients, bpLPCoeff);
-            rightLowPass.setBypassed<1>(false);
-            updateCoefficients(rightLowPass.get<2>().coefficients, bpLPCoeff);
-            rightLowPass.setBypassed<2>(false);
-            
-            updateCoefficients(leftHPChain.get<0>().coefficients, hpCoeff);
-            leftHPChain.setBypassed<0>(false);
-            updateCoefficients(leftHPChain.get<1>().coefficients, hpCoeff);
-            leftHPChain.setBypassed<1>(false);
-            updateCoefficients(leftHPChain.get<2>().coefficients, hpCoeff);
-            leftHPChain.setBypassed<2>(false);
-            
-            updateCoefficients(rightHPChain.get<0>().coefficients, hpCoeff);
-            rightHPChain.setBypassed<0>(false);
-            updateCoefficients(rightHPChain.get<1>().coefficients, hpCoeff);
-            rightHPChain.setBypassed<1>(false);
-            updateCoefficients(rightHPChain.get<2>().coefficients, hpCoeff);
-            rightHPChain.setBypassed<2>(false);
-            
-            updateCoefficients(leftLPChain.get<0>().coefficients, lpCoeff);
-            leftLPChain.setBypassed<0>(false);
-            updateCoefficients(leftLPChain.get<1>().coefficients, lpCoeff);
-            leftLPChain.setBypassed<1>(false);
-            updateCoefficients(leftLPChain.get<2>().coefficients, lpCoeff);
-            leftLPChain.setBypassed<2>(false);
-            
-            updateCoefficients(rightLPChain.get<0>().coefficients, lpCoeff);
-            rightLPChain.setBypassed<0>(false);
-            updateCoefficients(rightLPChain.get<1>().coefficients, lpCoeff);
-            rightLPChain.setBypassed<1>(false);
-            updateCoefficients(rightLPChain.get<2>().coefficients, lpCoeff);
-            rightLPChain.setBypassed<2>(false);
-            
-            break;
+            sliceSize = juce::jmin(sliceSize, static_cast<size_t>(crossoverUpdateInterval));
+            updateCrossovers(static_cast<int>(sliceSize));
         }
+        
+        auto bpSlice = bpBlock.getSubBlock(start, sliceSize);
+        auto lpSlice = lpBlock.getSubBlock(start, sliceSize);
+        auto hpSlice = hpBlock.getSubBlock(start, sliceSize);
+        
+        processChannel(leftBPChain, bpSlice, LEFT_CHANNEL);
+        processChannel(rightBPChain, bpSlice, RIGHT_CHANNEL);
+        
+        processChannel(leftLPChain, lpSlice, LEFT_CHANNEL);
+        processChannel(rightLPChain, lpSlice, RIGHT_CHANNEL);
+        
+        processChannel(leftHPChain, hpSlice, LEFT_CHANNEL);
+        processChannel(rightHPChain, hpSlice, RIGHT_CHANNEL);
+        
+        start += sliceSize;
     }
 }
 
+void KopczynskiXTCAudioProcessor::setCutChainType (CutChain& chain, juce::dsp::StateVariableTPTFilterType type)
+{
+    chain.get<CutChainPositions::Filter1>().setType(type);
+    chain.get<CutChainPositions::Filter2>().setType(type);
+    chain.get<CutChainPositions::Filter3>().setType(type);
+}
+
+void KopczynskiXTCAudioProcessor::updateCutChain (CutChain& chain, float cutoff, int filterType)
+{
+    /* TPT state-variable filters only recompute a few scalars on a cutoff change,
+       so all stages track the cutoff even when bypassed */
+    chain.get<CutChainPositions::Filter1>().setCutoffFrequency(cutoff);
+    chain.get<CutChainPositions::Filter2>().setCutoffFrequency(cutoff);
+    chain.get<CutChainPositions::Filter3>().setCutoffFrequency(cutoff);
+    
+    chain.setBypassed<CutChainPositions::Filter1>(false);
+    chain.setBypassed<CutChainPositions::Filter2>(filterType < FilterTypes::SecondOrder);
+    chain.setBypassed<CutChainPositions::Filter3>(filterType < FilterTypes::ThirdOrder);
+}
+
+void KopczynskiXTCAudioProcessor::updateFilters(const ChainSettings &chainSettings)
+{
+    /* keep cutoffs below nyquist for low sample rates */
+    auto maxCutoff = static_cast<float>(getSampleRate() * 0.49);
+    auto lowCrossover = juce::jmin(chainSettings.lowCrossover, maxCutoff);
+    auto highCrossover = juce::jmin(chainSettings.highCrossover, maxCutoff);
+    
+    updateCutChain(leftBPChain.get<BPChainPositions::BPHighPass>(), lowCrossover, chainSettings.filterType);
+    updateCutChain(rightBPChain.get<BPChainPositions::BPHighPass>(), lowCrossover, chainSettings.filterType);
+    
+    updateCutChain(leftBPChain.get<BPChainPositions::BPLowPass>(), highCrossover, chainSettings.filterType);
+    updateCutChain(rightBPChain.get<BPChainPositions::BPLowPass>(), highCrossover, chainSettings.filterType);
+    
+    updateCutChain(leftHPChain, lowCrossover, chainSettings.filterType);
+    updateCutChain(rightHPChain, lowCrossover, chainSettings.filterType);
+    
+    updateCutChain(leftLPChain, highCrossover, chainSettings.filterType);
+    updateCutChain(rightLPChain, highCrossover, chainSettings.filterType);
+}
+
 void KopczynskiXTCAudioProcessor::updateAttenuation(const ChainSettings &chainSettings)
 {
     float gainLin = juce::Decibels::decibelsToGain(chainSettings.attenuation);
@@ -445,17 +415,78 @@ void KopczynskiXTCAudioProcessor::updateAttenuation(const ChainSettings &chainSe
 
 void KopczynskiXTCAudioProcessor::updateDelay(const ChainSettings &chainSettings)
 {
-    leftRecChain.get<RecChainPositions::Delay>().setDelay(chainSettings.delay * 0.001f * getSampleRate());
-    rightRecChain.get<RecChainPositions::Delay>().setDelay(chainSettings.delay * 0.001f * getSampleRate());
+    /* delay lines run at the oversampled rate */
+    auto recSampleRate = getSampleRate() * (1 << chainSettings.oversampling);
+    
+    leftRecChain.get<RecChainPositions::Delay>().setDelay(chainSettings.delay * 0.001f * recSampleRate);
+    rightRecChain.get<RecChainPositions::Delay>().setDelay(chainSettings.delay * 0.001f * recSampleRate);
+}
+
+KopczynskiXTCAudioProcessor::Oversampling* KopczynskiXTCAudioProcessor::getOversampling(int oversamplingType) const
+{
+    switch ( oversamplingType )
+    {
+        case OversamplingTypes::Oversampling2x: return oversampling2x.get();
+        case OversamplingTypes::Oversampling4x: return oversampling4x.get();
+        default:                                return nullptr;
+    }
+}
+
+void KopczynskiXTCAudioProcessor::updateOversampling(const ChainSettings &chainSettings)
+{
+    if (chainSettings.oversampling == appliedOversampling)
+        return;
+    
+    appliedOversampling = chainSettings.oversampling;
+    
+    /* state from the previous rate is meaningless at the new one */
+    leftRecChain.reset();
+    rightRecChain.reset();
+    
+    int latency = 0;
+    
+    if (auto* oversampling = getOversampling(appliedOversampling))
+    {
+        oversampling->reset();
+        latency = juce::roundToInt(oversampling->getLatencyInSamples());
+    }
+    
+    /* pad the BP path up to the fixed reported latency, no host call from the audio thread */
+    bpLatencyDelay.reset();
+    bpLatencyDelay.setDelay(static_cast<float>(reportedLatency - latency));
 }
 
 void KopczynskiXTCAudioProcessor::updateAll()
 {
     auto chainSettings = getChainSettings(apvts);
     
+    updateOversampling(chainSettings);
     updateAttenuation(chainSettings);
     updateDelay(chainSettings);
-    updateFilters(chainSettings);
+    
+    /* crossovers ramp towards the parameters inside splitBands */
+    lowCrossoverSmoother.setTargetValue(chainSettings.lowCrossover);
+    highCrossoverSmoother.setTargetValue(chainSettings.highCrossover);
+    
+    /* only touch the 24 filter stages here when the slope changes or after prepareToPlay,
+       crossover ramps retune them from splitBands and settled crossovers need nothing */
+    if (filtersNeedUpdate || chainSettings.filterType != filterSettings.filterType)
+    {
+        filterSettings = chainSettings;
+        filterSettings.lowCrossover = lowCrossoverSmoother.getCurrentValue();
+        filterSettings.highCrossover = highCrossoverSmoother.getCurrentValue();
+        
+        updateFilters(filterSettings);
+        filtersNeedUpdate = false;
+    }
+}
+
+void KopczynskiXTCAudioProcessor::updateCrossovers(int numSamples)
+{
+    filterSettings.lowCrossover = lowCrossoverSmoother.skip(numSamples);
+    filterSettings.highCrossover = highCrossoverSmoother.skip(numSamples);
+    
+    updateFilters(filterSettings);
 }
 
 //==============================================================================
@@ -491,6 +522,9 @@ ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
     settings.attenuation = apvts.getRawParameterValue("Attenuation")->load();
     settings.delay = apvts.getRawParameterValue("Delay")->load();
     settings.filterType = apvts.getRawParameterValue("Filter Type")->load();
+    settings.lowCrossover = apvts.getRawParameterValue("Low Crossover")->load();
+    settings.highCrossover = apvts.getRawParameterValue("High Crossover")->load();
+    settings.oversampling = apvts.getRawParameterValue("Oversampling")->load();
     
     return settings;
 }
@@ -521,6 +555,21 @@ juce::AudioProcessorValueTreeState::ParameterLayout
     
     layout.add(std::make_unique<juce::AudioParameterChoice>("Filter Type", "Filter Type", stringArray, 0));
     
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Low Crossover",
+                                                           "Low Crossover",
+                                                           juce::NormalisableRange<float>(20.f, 1000.f, 1.f, 0.5f),
+                                                           250.f));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("High Crossover",
+                                                           "High Crossover",
+                                                           juce::NormalisableRange<float>(1000.f, 20000.f, 1.f, 0.25f),
+                                                           5000.f));
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Oversampling",
+                                                            "Oversampling",
+                                                            juce::StringArray { "Off", "2x", "4x" },
+                                                            0));
+    
     return layout;
 }
 
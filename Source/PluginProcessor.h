@@ -18,6 +18,9 @@ struct ChainSettings
     float attenuation { 0 };
     float delay { 0 };
     int filterType { 0 };
+    float lowCrossover { 0 };
+    float highCrossover { 0 };
+    int oversampling { 0 };
 };
 
 ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
@@ -69,9 +72,12 @@ public:
     juce::AudioProcessorValueTreeState apvts {*this, nullptr, "Parameters", createParameterLayout()};
 
 private:
-    using Filter = juce::dsp::IIR::Filter<float>;
+    using Filter = juce::dsp::StateVariableTPTFilter<float>;
     using Gain = juce::dsp::Gain<float>;
     using DelayLine = juce::dsp::DelayLine<float>;
+    using LatencyDelayLine = juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None>;
+    using Oversampling = juce::dsp::Oversampling<float>;
+    using CrossoverSmoother = juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative>;
     
     using RecChain = juce::dsp::ProcessorChain<Gain, DelayLine>;
     using CutChain = juce::dsp::ProcessorChain<Filter, Filter, Filter>;
@@ -83,6 +89,27 @@ private:
     
     CutChain leftHPChain, rightHPChain, leftLPChain, rightLPChain;
     
+    /* polyphase half-band oversampling around the recursion only. the 4x latency is
+       always reported, so every path is padded to it and the host never sees it change */
+    std::unique_ptr<Oversampling> oversampling2x, oversampling4x;
+    LatencyDelayLine bpLatencyDelay, lpLatencyDelay, hpLatencyDelay;
+    int reportedLatency { 0 };
+    
+    /* per-band work buffers, sized in prepareToPlay */
+    juce::AudioBuffer<float> bpBuffer, lpBuffer, hpBuffer;
+    int maxSubBlockSize { 512 };
+    
+    /* crossovers ramp towards the parameters and retune the filters every few samples while moving */
+    CrossoverSmoother lowCrossoverSmoother, highCrossoverSmoother;
+    static constexpr int crossoverUpdateInterval = 16;
+    
+    /* filter settings currently applied, with the smoothed crossovers */
+    ChainSettings filterSettings;
+    bool filtersNeedUpdate { true };
+    
+    /* oversampling type currently in use, -1 forces an update after prepareToPlay */
+    int appliedOversampling { -1 };
+    
     enum BPChainPositions
     {
         BPLowPass,
@@ -109,12 +136,28 @@ private:
         ThirdOrder
     };
     
-    using Coefficients = Filter::CoefficientsPtr;
+    enum OversamplingTypes
+    {
+        NoOversampling,
+        Oversampling2x,
+        Oversampling4x
+    };
     
     void updateFilters (const ChainSettings& chainSettings);
-    static void updateCoefficients (Coefficients& old, const Coefficients& replacements);
+    void updateCrossovers (int numSamples);
+    void splitBands (juce::dsp::AudioBlock<float>& bpBlock,
+                     juce::dsp::AudioBlock<float>& lpBlock,
+                     juce::dsp::AudioBlock<float>& hpBlock);
+    template <typename ChainType>
+    static void processChannel (ChainType& chain, const juce::dsp::AudioBlock<float>& block, size_t channel);
+    static void setCutChainType (CutChain& chain, juce::dsp::StateVariableTPTFilterType type);
+    static void updateCutChain (CutChain& chain, float cutoff, int filterType);
     void updateAttenuation (const ChainSettings& chainSettings);
     void updateDelay (const ChainSettings& chainSettings);
+    void updateOversampling (const ChainSettings& chainSettings);
+    Oversampling* getOversampling (int oversamplingType) const;
+    void processSubBlock (juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+    void processRecursion (juce::dsp::AudioBlock<float>& block);
     void updateAll();
     
     //==============================================================================
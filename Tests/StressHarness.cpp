@@ -0,0 +1,365 @@
+/*
+  ==============================================================================
+
+    Real-time safety stress harness for KopczynskiXTCAudioProcessor.
+
+    Drives processBlock with randomized block sizes (including 1 and
+    non-power-of-two sizes), mid-stream prepareToPlay sample rate changes
+    and randomized parameter automation. Fails if the audio thread
+    allocates, locks or makes blocking system calls, or if the output is
+    non-finite or runaway, and reports per-block timing percentiles.
+
+    usage: StressHarness [--blocks N] [--seed S]
+
+    Lock and system call detection interposes libc and is Linux only,
+    allocation detection works everywhere.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/PluginProcessor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#if JUCE_LINUX
+ #include <cerrno>
+ #include <dlfcn.h>
+ #include <pthread.h>
+ #include <sched.h>
+ #include <semaphore.h>
+ #include <time.h>
+ #include <unistd.h>
+#endif
+
+//==============================================================================
+namespace
+{
+    /* set only around processBlock, anything the hooks see while it is set is a violation */
+    thread_local bool isAudioThread = false;
+
+    std::atomic<juce::int64> audioThreadAllocations { 0 };
+    std::atomic<juce::int64> audioThreadLocks { 0 };
+    std::atomic<juce::int64> audioThreadSyscalls { 0 };
+
+    inline void noteAllocation() noexcept   { if (isAudioThread) ++audioThreadAllocations; }
+    inline void noteLock() noexcept         { if (isAudioThread) ++audioThreadLocks; }
+    inline void noteSyscall() noexcept      { if (isAudioThread) ++audioThreadSyscalls; }
+
+    struct ScopedAudioThread
+    {
+        ScopedAudioThread()  { isAudioThread = true; }
+        ~ScopedAudioThread() { isAudioThread = false; }
+    };
+}
+
+//==============================================================================
+#if JUCE_LINUX
+
+/* route the malloc family through glibc's internal entry points,
+   operator new/delete end up here as well */
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void  __libc_free (void*);
+    void* __libc_memalign (size_t, size_t);
+    void* __libc_valloc (size_t);
+
+    void* malloc (size_t size) noexcept                { noteAllocation(); return __libc_malloc (size); }
+    void* calloc (size_t num, size_t size) noexcept    { noteAllocation(); return __libc_calloc (num, size); }
+    void* realloc (void* ptr, size_t size) noexcept    { noteAllocation(); return __libc_realloc (ptr, size); }
+    void* aligned_alloc (size_t align, size_t size) noexcept { noteAllocation(); return __libc_memalign (align, size); }
+    void* memalign (size_t align, size_t size) noexcept      { noteAllocation(); return __libc_memalign (align, size); }
+    void* valloc (size_t size) noexcept                      { noteAllocation(); return __libc_valloc (size); }
+
+    void free (void* ptr) noexcept
+    {
+        if (ptr != nullptr)
+            noteAllocation();
+
+        __libc_free (ptr);
+    }
+
+    int posix_memalign (void** result, size_t align, size_t size) noexcept
+    {
+        noteAllocation();
+        *result = __libc_memalign (align, size);
+        return *result != nullptr ? 0 : ENOMEM;
+    }
+}
+
+/* locks and blocking calls are forwarded to the next definition in link order */
+#define XTC_INTERPOSE(note, returnType, name, params, args, exceptionSpec)         \
+    extern "C" returnType name params exceptionSpec                               \
+    {                                                                             \
+        using Function = returnType (*) params;                                   \
+        static std::atomic<Function> next { nullptr };                            \
+        auto fn = next.load();                                                    \
+                                                                                  \
+        if (fn == nullptr)                                                        \
+            next.store (fn = reinterpret_cast<Function> (dlsym (RTLD_NEXT, #name))); \
+                                                                                  \
+        note();                                                                   \
+        return fn args;                                                           \
+    }
+
+XTC_INTERPOSE (noteLock, int, pthread_mutex_lock, (pthread_mutex_t* m), (m), noexcept)
+XTC_INTERPOSE (noteLock, int, pthread_mutex_timedlock, (pthread_mutex_t* m, const struct timespec* t), (m, t), noexcept)
+XTC_INTERPOSE (noteLock, int, pthread_mutex_clocklock, (pthread_mutex_t* m, clockid_t c, const struct timespec* t), (m, c, t), noexcept)
+XTC_INTERPOSE (noteLock, int, pthread_spin_lock, (pthread_spinlock_t* l), (l), noexcept)
+XTC_INTERPOSE (noteLock, int, pthread_rwlock_rdlock, (pthread_rwlock_t* l), (l), noexcept)
+XTC_INTERPOSE (noteLock, int, pthread_rwlock_wrlock, (pthread_rwlock_t* l), (l), noexcept)
+XTC_INTERPOSE (noteLock, int, pthread_cond_wait, (pthread_cond_t* c, pthread_mutex_t* m), (c, m), )
+XTC_INTERPOSE (noteLock, int, pthread_cond_timedwait, (pthread_cond_t* c, pthread_mutex_t* m, const struct timespec* t), (c, m, t), )
+XTC_INTERPOSE (noteLock, int, pthread_cond_clockwait, (pthread_cond_t* c, pthread_mutex_t* m, clockid_t k, const struct timespec* t), (c, m, k, t), )
+XTC_INTERPOSE (noteLock, int, sem_wait, (sem_t* s), (s), )
+
+XTC_INTERPOSE (noteSyscall, int, nanosleep, (const struct timespec* req, struct timespec* rem), (req, rem), )
+XTC_INTERPOSE (noteSyscall, int, clock_nanosleep, (clockid_t c, int flags, const struct timespec* req, struct timespec* rem), (c, flags, req, rem), )
+XTC_INTERPOSE (noteSyscall, int, usleep, (useconds_t usec), (usec), )
+XTC_INTERPOSE (noteSyscall, int, sched_yield, (void), (), noexcept)
+XTC_INTERPOSE (noteSyscall, ssize_t, read, (int fd, void* buf, size_t count), (fd, buf, count), )
+XTC_INTERPOSE (noteSyscall, ssize_t, write, (int fd, const void* buf, size_t count), (fd, buf, count), )
+XTC_INTERPOSE (noteSyscall, int, fsync, (int fd), (fd), )
+
+#undef XTC_INTERPOSE
+
+#else
+
+/* without libc interposition only C++ allocations are visible */
+void* operator new (std::size_t size)
+{
+    noteAllocation();
+
+    if (auto* ptr = std::malloc (size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)                                  { return operator new (size); }
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept    { noteAllocation(); return std::malloc (size); }
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept  { noteAllocation(); return std::malloc (size); }
+
+void operator delete (void* ptr) noexcept
+{
+    if (ptr != nullptr)
+        noteAllocation();
+
+    std::free (ptr);
+}
+
+void operator delete[] (void* ptr) noexcept                  { operator delete (ptr); }
+void operator delete (void* ptr, std::size_t) noexcept       { operator delete (ptr); }
+void operator delete[] (void* ptr, std::size_t) noexcept     { operator delete (ptr); }
+
+#endif
+
+//==============================================================================
+namespace
+{
+    /* input peaks at 0 dBFS and the recursion only ever attenuates,
+       so the three summed bands cannot legitimately reach +18 dBFS */
+    constexpr float outputLimit = 8.f;
+
+    const double sampleRates[]      { 44100.0, 48000.0, 88200.0, 96000.0, 192000.0 };
+    const int preparedBlockSizes[]  { 64, 256, 441, 512, 1024 };
+    const int blockSizes[]          { 1, 2, 3, 7, 13, 31, 64, 100, 127, 128, 255, 256,
+                                      441, 480, 512, 777, 1000, 1024, 2048, 4096 };
+
+    /* the first three are automated most often, the rest now and then */
+    const char* const automatedParameters[] { "Attenuation", "Delay", "Filter Type",
+                                              "Low Crossover", "High Crossover", "Oversampling" };
+
+    template <typename Type, size_t size>
+    const Type& pick (juce::Random& random, const Type (&items)[size])
+    {
+        return items[(size_t) random.nextInt ((int) size)];
+    }
+
+    void prepare (KopczynskiXTCAudioProcessor& processor, juce::Random& random)
+    {
+        auto sampleRate = pick (random, sampleRates);
+        auto blockSize = pick (random, preparedBlockSizes);
+
+        processor.releaseResources();
+        processor.setPlayConfigDetails (2, 2, sampleRate, blockSize);
+        processor.prepareToPlay (sampleRate, blockSize);
+    }
+
+    void automate (KopczynskiXTCAudioProcessor& processor, juce::Random& random)
+    {
+        for (int i = 0; i < 3; ++i)
+            if (random.nextFloat() < 0.3f)
+                processor.apvts.getParameter (automatedParameters[i])->setValueNotifyingHost (random.nextFloat());
+
+        if (random.nextFloat() < 0.02f)
+            processor.apvts.getParameter (pick (random, automatedParameters))->setValueNotifyingHost (random.nextFloat());
+    }
+
+    void fillInput (juce::AudioBuffer<float>& buffer, juce::Random& random, double& phase)
+    {
+        /* noise with a swept sine on top, occasionally at full scale */
+        auto level = random.nextFloat() < 0.01f ? 1.f : 0.25f;
+        auto increment = juce::MathConstants<double>::twoPi * (50.0 + 10000.0 * random.nextDouble()) / 48000.0;
+
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        {
+            auto sine = static_cast<float> (std::sin (phase));
+            phase += increment;
+
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                buffer.setSample (channel, i, level * (0.5f * sine + 0.5f * (2.f * random.nextFloat() - 1.f)));
+        }
+    }
+
+    juce::int64 checkOutput (const juce::AudioBuffer<float>& buffer)
+    {
+        juce::int64 badSamples = 0;
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            auto* samples = buffer.getReadPointer (channel);
+
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                if (! std::isfinite (samples[i]) || std::abs (samples[i]) > outputLimit)
+                    ++badSamples;
+        }
+
+        return badSamples;
+    }
+
+    /* a static or symbolic link silently bypasses the hooks, so prove they fire before trusting zeros */
+    bool hooksAreLive()
+    {
+        {
+            ScopedAudioThread audioThread;
+
+            auto* volatile object = new char[16];
+            delete[] object;
+
+           #if JUCE_LINUX
+            auto* volatile block = std::malloc (16);
+            std::free (block);
+
+            std::mutex mutex;
+            mutex.lock();
+            mutex.unlock();
+
+            usleep (0);
+           #endif
+        }
+
+        auto live = audioThreadAllocations.load() > 0;
+
+       #if JUCE_LINUX
+        live = live && audioThreadLocks.load() > 0 && audioThreadSyscalls.load() > 0;
+       #else
+        std::cout << "lock and blocking call detection is unavailable on this platform" << std::endl;
+       #endif
+
+        audioThreadAllocations = 0;
+        audioThreadLocks = 0;
+        audioThreadSyscalls = 0;
+
+        return live;
+    }
+
+    double percentileMicroseconds (const std::vector<juce::int64>& sortedTicks, double percentile)
+    {
+        auto index = (size_t) std::ceil (percentile * 0.01 * (double) sortedTicks.size());
+        auto ticks = sortedTicks[juce::jlimit ((size_t) 0, sortedTicks.size() - 1, index == 0 ? 0 : index - 1)];
+
+        return 1.0e6 * (double) ticks / (double) juce::Time::getHighResolutionTicksPerSecond();
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args (argc, argv);
+
+    auto numBlocks = args.containsOption ("--blocks") ? args.getValueForOption ("--blocks").getLargeIntValue() : 200000;
+    auto seed = args.containsOption ("--seed") ? args.getValueForOption ("--seed").getLargeIntValue()
+                                               : juce::Time::currentTimeMillis();
+
+    std::cout << "KopczynskiXTC stress harness, " << numBlocks << " blocks, seed " << seed << std::endl;
+
+    if (! hooksAreLive())
+    {
+        std::cout << "FAILED: audio thread hooks are not being called, check how the harness is linked" << std::endl;
+        return 1;
+    }
+
+    juce::Random random (seed);
+    KopczynskiXTCAudioProcessor processor;
+    prepare (processor, random);
+
+    /* everything the loop touches is allocated up front */
+    juce::AudioBuffer<float> buffer (2, blockSizes[std::size (blockSizes) - 1]);
+    juce::MidiBuffer midiMessages;
+    std::vector<juce::int64> blockTicks;
+    blockTicks.reserve ((size_t) numBlocks);
+
+    double phase = 0.0;
+    juce::int64 badSamples = 0;
+    int numPrepares = 1;
+
+    for (juce::int64 block = 0; block < numBlocks; ++block)
+    {
+        /* host-side work happens off the flagged audio thread */
+        if (random.nextFloat() < 0.0005f)
+        {
+            prepare (processor, random);
+            ++numPrepares;
+        }
+
+        automate (processor, random);
+
+        buffer.setSize (2, pick (random, blockSizes), false, false, true);
+        fillInput (buffer, random, phase);
+
+        auto start = juce::Time::getHighResolutionTicks();
+
+        {
+            ScopedAudioThread audioThread;
+            processor.processBlock (buffer, midiMessages);
+        }
+
+        blockTicks.push_back (juce::Time::getHighResolutionTicks() - start);
+        badSamples += checkOutput (buffer);
+    }
+
+    std::sort (blockTicks.begin(), blockTicks.end());
+
+    std::cout << "prepareToPlay calls:          " << numPrepares << "\n"
+              << "audio thread allocations:     " << audioThreadAllocations.load() << "\n"
+              << "audio thread locks:           " << audioThreadLocks.load() << "\n"
+              << "audio thread blocking calls:  " << audioThreadSyscalls.load() << "\n"
+              << "non-finite or runaway samples: " << badSamples << "\n";
+
+    if (! blockTicks.empty())
+        std::cout << "block time p50 / p99 / p99.99 / max (us): "
+                  << percentileMicroseconds (blockTicks, 50.0) << " / "
+                  << percentileMicroseconds (blockTicks, 99.0) << " / "
+                  << percentileMicroseconds (blockTicks, 99.99) << " / "
+                  << percentileMicroseconds (blockTicks, 100.0) << "\n";
+
+    auto failed = audioThreadAllocations.load() != 0
+               || audioThreadLocks.load() != 0
+               || audioThreadSyscalls.load() != 0
+               || badSamples != 0;
+
+    std::cout << (failed ? "FAILED" : "PASSED") << std::endl;
+
+    return failed ? 1 : 0;
+}